@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "iterstate.h"
+#include "scheduler.h"
+
+const int    WIDTH  = 1920;
+const int    HEIGHT = 1080;
+const float  RADIUS = 100.0f;
+const int    RUNS   = 5;    // по умолчанию, можно задать первым аргументом
+
+// Виды для замеров: центр (x, y) на комплексной плоскости, масштаб и ограничение итераций
+struct BenchView {
+    const char* name;
+    float       x;
+    float       y;
+    float       zoom;
+    int         maxIterations;
+};
+
+const BenchView VIEWS[] = {
+    {"full",      -0.75f,   0.0f,   1.0f,   256},
+    {"seahorse",  -0.745f,  0.1f,   0.01f,  1024},
+    {"elephant",   0.275f,  0.006f, 0.01f,  1024},
+    {"spiral",    -0.7436f, 0.1318f, 0.001f, 4096},
+};
+
+struct RenderJob {
+    float xC;
+    float yC;
+    float zoom;
+    int   maxIterations;
+    int*  iterations;
+};
+
+// Состояние точек плитки лежит в арене потока, в общий буфер пишется только результат
+void renderTile(const Tile* tile, Arena* arena, void* ctx) {
+    RenderJob* job = (RenderJob*)ctx;
+    int w = tile->x1 - tile->x0;
+    int h = tile->y1 - tile->y0;
+
+    IterState state;
+    iterStateCreateIn(&state, w, h, RADIUS, arenaAlloc(arena, iterStateBytes(w, h)));
+    iterStateResetWindow(&state, job->xC, job->yC, job->zoom, tile->x0, tile->y0, WIDTH, HEIGHT);
+    iterStateAdvance(&state, job->maxIterations);
+
+    for (int y = 0; y < h; y++) {
+        int* out = job->iterations + (tile->y0 + y) * WIDTH + tile->x0;
+        for (int x = 0; x < w; x++) {
+            int i = y * w + x;
+            out[x] = state.escaped[i] ? state.iterations[i] : job->maxIterations;
+        }
+    }
+}
+
+// Медиана времени кадра в миллисекундах
+double measure(TileScheduler* sched, const BenchView* view, int* iterations, int runs) {
+    RenderJob job = {view->x + 2.5f - 1.75f * view->zoom, view->y + 1.0f - view->zoom,
+                     view->zoom, view->maxIterations, iterations};
+
+    std::vector<double> times;
+    for (int run = 0; run < runs; run++) {
+        auto start = std::chrono::steady_clock::now();
+        schedulerRun(sched, renderTile, &job);
+        auto end = std::chrono::steady_clock::now();
+        times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+struct BenchConfig {
+    const char* name;
+    int         nodes;
+    int         threads;
+};
+
+int main(int argc, char* argv[]) {
+    int runs = argc > 1 ? atoi(argv[1]) : RUNS;
+    if (runs < 1)
+        runs = 1;
+
+    int nodeCount = numaNodeCount();
+
+    std::vector<BenchConfig> configs;
+    configs.push_back({"1 thread",  1, 1});
+    configs.push_back({"1 socket",  1, 0});
+    if (nodeCount > 1)
+        configs.push_back({"2 sockets", 2, 0});
+
+    int viewCount = sizeof(VIEWS) / sizeof(VIEWS[0]);
+    std::vector<std::vector<double> > times(configs.size(), std::vector<double>(viewCount));
+
+    std::vector<int> reference((size_t)WIDTH * HEIGHT);
+
+    for (size_t c = 0; c < configs.size(); c++) {
+        TileScheduler* sched = schedulerCreate(WIDTH, HEIGHT, configs[c].nodes, configs[c].threads);
+        if (!sched) {
+            printf("%s: cannot create scheduler\n", configs[c].name);
+            return 1;
+        }
+
+        int* iterations = (int*)schedulerAllocFrame(sched, sizeof(int));
+        if (!iterations) {
+            printf("%s: cannot allocate frame\n", configs[c].name);
+            schedulerDestroy(sched);
+            return 1;
+        }
+
+        int tileWidth = 0, tileHeight = 0;
+        schedulerTileSize(sched, &tileWidth, &tileHeight);
+        printf("%-10s %d node(s), %d thread(s), tile %dx%d\n", configs[c].name,
+               schedulerNodes(sched), schedulerThreads(sched), tileWidth, tileHeight);
+
+        for (int v = 0; v < viewCount; v++) {
+            times[c][v] = measure(sched, &VIEWS[v], iterations, runs);
+
+            // все конфигурации должны давать одинаковое изображение
+            if (c == 0 && v == viewCount - 1)
+                memcpy(reference.data(), iterations, reference.size() * sizeof(int));
+            else if (v == viewCount - 1 && memcmp(reference.data(), iterations, reference.size() * sizeof(int)) != 0)
+                printf("%s: image differs from single thread\n", configs[c].name);
+        }
+
+        schedulerFreeFrame(sched, iterations, sizeof(int));
+        schedulerDestroy(sched);
+    }
+
+    printf("\n%-10s", "view");
+    for (size_t c = 0; c < configs.size(); c++)
+        printf(" | %12s", configs[c].name);
+    if (nodeCount > 1)
+        printf(" | 2/1 sockets");
+    printf("\n");
+
+    for (int v = 0; v < viewCount; v++) {
+        printf("%-10s", VIEWS[v].name);
+        for (size_t c = 0; c < configs.size(); c++)
+            printf(" | %9.1f ms", times[c][v]);
+        if (nodeCount > 1)
+            printf(" | %10.2fx", times[1][v] / times[2][v]);
+        printf("\n");
+    }
+
+    if (nodeCount == 1)
+        printf("\nOnly one NUMA node available: 1 to 2 socket scaling not measured\n");
+
+    return 0;
+}
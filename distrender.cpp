@@ -0,0 +1,705 @@
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#include "iterstate.h"
+
+const float  RADIUS          = 100.0f;
+const int    TILE_SIZE       = 128;
+const int    POLL_MS         = 100;
+const double MIN_SLOW_MS     = 2000.0;   // задача считается медленной не раньше этого времени
+const double SLOW_FACTOR     = 4.0;      // ... и не раньше SLOW_FACTOR средних времен плитки
+const int    MAX_COPIES      = 2;        // сколько работников могут одновременно считать одну плитку
+
+// Протокол: заголовок и данные фиксированного формата, порядок байт машины.
+// Координатор шлет MSG_TASK, работник отвечает MSG_RESULT с числами итераций плитки.
+enum MsgType {
+    MSG_TASK   = 1,
+    MSG_RESULT = 2,
+};
+
+struct MsgHeader {
+    uint32_t type;
+    uint32_t size;      // размер данных после заголовка
+};
+
+struct TileTask {
+    uint32_t id;
+    int32_t  x0, y0;
+    int32_t  x1, y1;
+    int32_t  width;     // размер всего кадра
+    int32_t  height;
+    float    xC;
+    float    yC;
+    float    zoom;
+    int32_t  maxIterations;
+};
+
+struct Options {
+    int         workers;
+    int         port;
+    float       x, y;
+    float       zoom;
+    int         width, height;
+    int         maxIterations;
+    int         frames;
+    float       zoomStep;
+    int         tile;
+    std::string out;
+};
+
+static double nowMs() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool readFull(int fd, void* data, size_t size) {
+    char* p = (char*)data;
+    while (size) {
+        ssize_t n = read(fd, p, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+static bool writeFull(int fd, const void* data, size_t size) {
+    const char* p = (const char*)data;
+    while (size) {
+        ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            struct pollfd pfd = {fd, POLLOUT, 0};
+            poll(&pfd, 1, POLL_MS);
+            continue;
+        }
+        if (n <= 0)
+            return false;
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+static bool sendMessage(int fd, uint32_t type, const void* data, size_t size) {
+    MsgHeader header = {type, (uint32_t)size};
+    return writeFull(fd, &header, sizeof(header)) && writeFull(fd, data, size);
+}
+
+// ---------------------------------------------------------------- работник
+
+// Считает плитки, пока координатор не закроет соединение
+static int workerLoop(int fd) {
+    IterState state = {};
+    int stateW = 0, stateH = 0;
+
+    std::vector<char> result;
+
+    while (true) {
+        MsgHeader header;
+        TileTask  task;
+        if (!readFull(fd, &header, sizeof(header)))
+            break;
+        if (header.type != MSG_TASK || header.size != sizeof(task) || !readFull(fd, &task, sizeof(task)))
+            break;
+
+        int w = task.x1 - task.x0;
+        int h = task.y1 - task.y0;
+        if (w != stateW || h != stateH) {
+            if (stateW)
+                iterStateDestroy(&state);
+            iterStateCreate(&state, w, h, RADIUS);
+            stateW = w;
+            stateH = h;
+        }
+
+        iterStateResetWindow(&state, task.xC, task.yC, task.zoom, task.x0, task.y0, task.width, task.height);
+        iterStateAdvance(&state, task.maxIterations);
+
+        result.resize(sizeof(uint32_t) + (size_t)w * h * sizeof(int32_t));
+        memcpy(result.data(), &task.id, sizeof(uint32_t));
+        int32_t* iterations = (int32_t*)(result.data() + sizeof(uint32_t));
+        for (int i = 0; i < w * h; i++)
+            iterations[i] = state.escaped[i] ? state.iterations[i] : task.maxIterations;
+
+        if (!sendMessage(fd, MSG_RESULT, result.data(), result.size()))
+            break;
+    }
+
+    if (stateW)
+        iterStateDestroy(&state);
+    close(fd);
+    return 0;
+}
+
+static int connectTo(const char* address) {
+    std::string host = address;
+    size_t colon = host.rfind(':');
+    if (colon == std::string::npos)
+        return -1;
+    std::string port = host.substr(colon + 1);
+    host = host.substr(0, colon);
+
+    struct addrinfo hints = {};
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo* list = NULL;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &list) != 0)
+        return -1;
+
+    int fd = -1;
+    for (struct addrinfo* ai = list; ai && fd < 0; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd >= 0 && connect(fd, ai->ai_addr, ai->ai_addrlen) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(list);
+
+    if (fd >= 0) {
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    return fd;
+}
+
+// ---------------------------------------------------------------- координатор
+
+enum TileStatus {
+    TILE_QUEUED,
+    TILE_RUNNING,
+    TILE_DONE,
+};
+
+struct TileJob {
+    int        frame;
+    TileTask   task;
+    TileStatus status;
+    int        copies;      // у скольких работников плитка сейчас в работе
+    double     started;     // время первой выдачи
+};
+
+struct Connection {
+    int               fd;
+    int               tile;     // плитка в работе или -1
+    std::vector<char> in;       // принятые, но еще не разобранные байты
+    bool              remote;
+};
+
+struct FrameBuffer {
+    std::vector<int32_t> iterations;
+    int                  remaining;    // сколько плиток кадра еще не получено
+};
+
+struct Coordinator {
+    Options                  options;
+    std::vector<TileJob>     tiles;
+    size_t                   nextQueued;   // плитки до этого номера уже выдавались
+    std::vector<int>         requeued;     // плитки потерянных работников
+    std::vector<FrameBuffer> frames;
+    std::vector<Connection>  connections;
+    int                      listenFd;
+    int                      tilesDone;
+    int                      framesDone;
+    int                      framesFailed;   // кадры, которые не удалось записать
+    double                   tileTimeSum;
+};
+
+static void setNonBlocking(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+static int spawnLocalWorker(Coordinator* coord) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+        return -1;
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+
+    if (pid == 0) {
+        // у работника остается только свой конец соединения
+        close(fds[0]);
+        if (coord->listenFd >= 0)
+            close(coord->listenFd);
+        for (const Connection& conn : coord->connections)
+            close(conn.fd);
+        _exit(workerLoop(fds[1]));
+    }
+
+    close(fds[1]);
+    setNonBlocking(fds[0]);
+    return fds[0];
+}
+
+static int listenOn(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr = {};
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port        = htons(port);
+
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 64) != 0) {
+        close(fd);
+        return -1;
+    }
+    setNonBlocking(fd);
+    return fd;
+}
+
+// Плитки всех кадров. Кадр f приближен в zoomStep^f раз относительно первого
+static void splitJob(Coordinator* coord) {
+    const Options* opt = &coord->options;
+
+    coord->frames.resize(opt->frames);
+    for (int f = 0; f < opt->frames; f++) {
+        float zoom = opt->zoom * powf(opt->zoomStep, (float)f);
+        float xC   = opt->x + 2.5f - 1.75f * zoom;
+        float yC   = opt->y + 1.0f - zoom;
+
+        for (int y = 0; y < opt->height; y += opt->tile) {
+            for (int x = 0; x < opt->width; x += opt->tile) {
+                TileJob job = {};
+                job.frame  = f;
+                job.status = TILE_QUEUED;
+
+                job.task.id            = (uint32_t)coord->tiles.size();
+                job.task.x0            = x;
+                job.task.y0            = y;
+                job.task.x1            = std::min(x + opt->tile, opt->width);
+                job.task.y1            = std::min(y + opt->tile, opt->height);
+                job.task.width         = opt->width;
+                job.task.height        = opt->height;
+                job.task.xC            = xC;
+                job.task.yC            = yC;
+                job.task.zoom          = zoom;
+                job.task.maxIterations = opt->maxIterations;
+
+                coord->tiles.push_back(job);
+                coord->frames[f].remaining++;
+            }
+        }
+    }
+}
+
+static bool writeFrame(const Coordinator* coord, int f) {
+    const Options* opt = &coord->options;
+
+    char name[32] = {};
+    snprintf(name, sizeof(name), "_%04d.ppm", f);
+    std::string path = opt->out + name;
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+
+    fprintf(file, "P6\n%d %d\n255\n", opt->width, opt->height);
+
+    std::vector<unsigned char> row(opt->width * 3);
+    const int32_t* iterations = coord->frames[f].iterations.data();
+    for (int y = 0; y < opt->height; y++) {
+        for (int x = 0; x < opt->width; x++) {
+            int n = iterations[y * opt->width + x];
+            row[3 * x + 0] = (n * 6) % 256;
+            row[3 * x + 1] = 0;
+            row[3 * x + 2] = (n * 10) % 256;
+        }
+        fwrite(row.data(), 1, row.size(), file);
+    }
+
+    bool ok = !ferror(file);
+    ok = (fclose(file) == 0) && ok;
+    fprintf(stderr, "frame %d/%d: %s\n", f + 1, opt->frames, path.c_str());
+    return ok;
+}
+
+// Проверяет, что по префиксу можно создать файл, до того как считать кадры
+static bool outputWritable(const std::string& prefix) {
+    std::string path = prefix + "_probe.tmp";
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+
+    fclose(file);
+    unlink(path.c_str());
+    return true;
+}
+
+static void storeResult(Coordinator* coord, const char* data, size_t size) {
+    uint32_t id = 0;
+    if (size < sizeof(id))
+        return;
+    memcpy(&id, data, sizeof(id));
+    if (id >= coord->tiles.size())
+        return;
+
+    TileJob* job = &coord->tiles[id];
+    job->copies = std::max(0, job->copies - 1);
+
+    // второй ответ на перевыданную плитку не нужен
+    if (job->status == TILE_DONE)
+        return;
+
+    const TileTask* task = &job->task;
+    int w = task->x1 - task->x0;
+    int h = task->y1 - task->y0;
+    if (size != sizeof(id) + (size_t)w * h * sizeof(int32_t))
+        return;
+
+    FrameBuffer* frame = &coord->frames[job->frame];
+    if (frame->iterations.empty())
+        frame->iterations.resize((size_t)task->width * task->height);
+
+    const int32_t* src = (const int32_t*)(data + sizeof(id));
+    for (int y = 0; y < h; y++)
+        memcpy(&frame->iterations[(size_t)(task->y0 + y) * task->width + task->x0], src + y * w, w * sizeof(int32_t));
+
+    job->status = TILE_DONE;
+    coord->tilesDone++;
+    coord->tileTimeSum += nowMs() - job->started;
+
+    if (--frame->remaining == 0) {
+        if (!writeFrame(coord, job->frame)) {
+            fprintf(stderr, "failed to write frame %d\n", job->frame);
+            coord->framesFailed++;
+        }
+        std::vector<int32_t>().swap(frame->iterations);
+        coord->framesDone++;
+    }
+}
+
+static void dropConnection(Coordinator* coord, size_t c) {
+    Connection* conn = &coord->connections[c];
+    if (conn->tile >= 0) {
+        TileJob* job = &coord->tiles[conn->tile];
+        job->copies = std::max(0, job->copies - 1);
+        if (job->status == TILE_RUNNING && job->copies == 0) {
+            job->status = TILE_QUEUED;
+            coord->requeued.push_back(conn->tile);
+        }
+        fprintf(stderr, "worker lost, tile %d requeued\n", conn->tile);
+    }
+    else
+        fprintf(stderr, "worker lost\n");
+
+    close(conn->fd);
+    coord->connections.erase(coord->connections.begin() + c);
+}
+
+// Разбирает все полностью принятые сообщения; false - соединение надо закрыть
+static bool readMessages(Coordinator* coord, Connection* conn) {
+    char buffer[65536];
+    while (true) {
+        ssize_t n = read(conn->fd, buffer, sizeof(buffer));
+        if (n > 0) {
+            conn->in.insert(conn->in.end(), buffer, buffer + n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        return false;
+    }
+
+    size_t offset = 0;
+    while (conn->in.size() - offset >= sizeof(MsgHeader)) {
+        MsgHeader header;
+        memcpy(&header, conn->in.data() + offset, sizeof(header));
+        // больше одной плитки работник прислать не может, иначе буфер рос бы без ограничений
+        if (header.type != MSG_RESULT ||
+            header.size > sizeof(uint32_t) + (size_t)coord->options.tile * coord->options.tile * sizeof(int32_t))
+            return false;
+        if (conn->in.size() - offset - sizeof(header) < header.size)
+            break;
+
+        storeResult(coord, conn->in.data() + offset + sizeof(header), header.size);
+        offset += sizeof(header) + header.size;
+        conn->tile = -1;
+    }
+    conn->in.erase(conn->in.begin(), conn->in.begin() + offset);
+    return true;
+}
+
+// Следующая плитка для свободного работника: сначала из очереди, затем
+// перевыдача плитки, которую другой работник считает слишком долго
+static int nextTile(Coordinator* coord, double now) {
+    while (!coord->requeued.empty()) {
+        int t = coord->requeued.back();
+        coord->requeued.pop_back();
+        if (coord->tiles[t].status == TILE_QUEUED)
+            return t;
+    }
+
+    while (coord->nextQueued < coord->tiles.size()) {
+        size_t i = coord->nextQueued++;
+        if (coord->tiles[i].status == TILE_QUEUED)
+            return (int)i;
+    }
+
+    // в работе не больше плиток, чем работников, поэтому ищем среди них
+    double average = coord->tilesDone ? coord->tileTimeSum / coord->tilesDone : 0;
+    double slow    = std::max(MIN_SLOW_MS, SLOW_FACTOR * average);
+    for (const Connection& conn : coord->connections) {
+        if (conn.tile < 0)
+            continue;
+
+        const TileJob* job = &coord->tiles[conn.tile];
+        if (job->status == TILE_RUNNING && job->copies < MAX_COPIES && now - job->started > slow)
+            return conn.tile;
+    }
+    return -1;
+}
+
+static void dispatch(Coordinator* coord) {
+    double now = nowMs();
+    for (size_t c = 0; c < coord->connections.size(); ) {
+        Connection* conn = &coord->connections[c];
+        if (conn->tile >= 0) {
+            c++;
+            continue;
+        }
+
+        int t = nextTile(coord, now);
+        if (t < 0)
+            break;
+
+        TileJob* job = &coord->tiles[t];
+        if (!sendMessage(conn->fd, MSG_TASK, &job->task, sizeof(job->task))) {
+            if (job->status == TILE_QUEUED)
+                coord->requeued.push_back(t);
+            dropConnection(coord, c);
+            continue;
+        }
+
+        if (job->status == TILE_QUEUED) {
+            job->status  = TILE_RUNNING;
+            job->started = now;
+        }
+        else
+            fprintf(stderr, "tile %d is slow, dispatched again\n", t);
+        job->copies++;
+        conn->tile = t;
+        c++;
+    }
+}
+
+static void acceptWorkers(Coordinator* coord) {
+    while (true) {
+        int fd = accept(coord->listenFd, NULL, NULL);
+        if (fd < 0)
+            break;
+
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        setNonBlocking(fd);
+
+        Connection conn = {fd, -1, std::vector<char>(), true};
+        coord->connections.push_back(conn);
+        fprintf(stderr, "remote worker connected (%zu workers)\n", coord->connections.size());
+    }
+}
+
+static int coordinatorRun(const Options* options) {
+    Coordinator coord;
+    coord.options      = *options;
+    coord.listenFd     = -1;
+    coord.nextQueued   = 0;
+    coord.tilesDone    = 0;
+    coord.framesDone   = 0;
+    coord.framesFailed = 0;
+    coord.tileTimeSum  = 0;
+
+    if (!outputWritable(options->out)) {
+        fprintf(stderr, "cannot write output %s_*.ppm: %s\n", options->out.c_str(), strerror(errno));
+        return 1;
+    }
+
+    // работники, завершившиеся сами, не остаются зомби
+    signal(SIGCHLD, SIG_IGN);
+    signal(SIGPIPE, SIG_IGN);
+
+    if (options->port > 0) {
+        coord.listenFd = listenOn(options->port);
+        if (coord.listenFd < 0) {
+            fprintf(stderr, "cannot listen on port %d: %s\n", options->port, strerror(errno));
+            return 1;
+        }
+        fprintf(stderr, "waiting for workers on port %d\n", options->port);
+    }
+
+    for (int i = 0; i < options->workers; i++) {
+        int fd = spawnLocalWorker(&coord);
+        if (fd < 0) {
+            fprintf(stderr, "cannot start worker: %s\n", strerror(errno));
+            break;
+        }
+        Connection conn = {fd, -1, std::vector<char>(), false};
+        coord.connections.push_back(conn);
+    }
+
+    splitJob(&coord);
+
+    double start = nowMs();
+    while (coord.framesDone < options->frames) {
+        if (coord.connections.empty() && coord.listenFd < 0) {
+            fprintf(stderr, "no workers left, %d of %zu tiles done\n", coord.tilesDone, coord.tiles.size());
+            return 1;
+        }
+
+        dispatch(&coord);
+
+        std::vector<struct pollfd> fds;
+        for (const Connection& conn : coord.connections) {
+            struct pollfd pfd = {conn.fd, POLLIN, 0};
+            fds.push_back(pfd);
+        }
+        if (coord.listenFd >= 0) {
+            struct pollfd pfd = {coord.listenFd, POLLIN, 0};
+            fds.push_back(pfd);
+        }
+
+        if (poll(fds.data(), fds.size(), POLL_MS) < 0 && errno != EINTR) {
+            perror("poll");
+            return 1;
+        }
+
+        // обход с конца, чтобы удаление соединения не сдвигало необработанные
+        for (size_t c = coord.connections.size(); c-- > 0; ) {
+            if (fds[c].revents && !readMessages(&coord, &coord.connections[c]))
+                dropConnection(&coord, c);
+        }
+
+        if (coord.listenFd >= 0 && (fds.back().revents & POLLIN))
+            acceptWorkers(&coord);
+    }
+
+    fprintf(stderr, "%zu tiles, %d frames in %.1f ms\n", coord.tiles.size(), options->frames, nowMs() - start);
+
+    for (const Connection& conn : coord.connections)
+        close(conn.fd);
+    if (coord.listenFd >= 0)
+        close(coord.listenFd);
+
+    if (coord.framesFailed > 0) {
+        fprintf(stderr, "%d of %d frames not written\n", coord.framesFailed, options->frames);
+        return 1;
+    }
+    return 0;
+}
+
+static void usage() {
+    fprintf(stderr,
+        "usage:\n"
+        "  distrender render [--workers N] [--listen PORT] [--center X Y] [--zoom Z]\n"
+        "                    [--size W H] [--iterations M] [--frames F] [--zoom-step S]\n"
+        "                    [--tile T] [--out PREFIX]\n"
+        "  distrender worker --connect HOST:PORT\n");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage();
+        return 1;
+    }
+
+    if (strcmp(argv[1], "worker") == 0) {
+        if (argc != 4 || strcmp(argv[2], "--connect") != 0) {
+            usage();
+            return 1;
+        }
+        signal(SIGPIPE, SIG_IGN);
+
+        int fd = connectTo(argv[3]);
+        if (fd < 0) {
+            fprintf(stderr, "cannot connect to %s\n", argv[3]);
+            return 1;
+        }
+        return workerLoop(fd);
+    }
+
+    if (strcmp(argv[1], "render") != 0) {
+        usage();
+        return 1;
+    }
+
+    Options options;
+    options.workers       = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    options.port          = 0;
+    options.x             = -0.75f;
+    options.y             = 0.0f;
+    options.zoom          = 1.0f;
+    options.width         = 800;
+    options.height        = 600;
+    options.maxIterations = 256;
+    options.frames        = 1;
+    options.zoomStep      = 1.0f;
+    options.tile          = TILE_SIZE;
+    options.out           = "mandelbrot";
+
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        int left = argc - i - 1;
+
+        if      (arg == "--workers"    && left >= 1) options.workers       = atoi(argv[++i]);
+        else if (arg == "--listen"     && left >= 1) options.port          = atoi(argv[++i]);
+        else if (arg == "--zoom"       && left >= 1) options.zoom          = atof(argv[++i]);
+        else if (arg == "--iterations" && left >= 1) options.maxIterations = atoi(argv[++i]);
+        else if (arg == "--frames"     && left >= 1) options.frames        = atoi(argv[++i]);
+        else if (arg == "--zoom-step"  && left >= 1) options.zoomStep      = atof(argv[++i]);
+        else if (arg == "--tile"       && left >= 1) options.tile          = atoi(argv[++i]);
+        else if (arg == "--out"        && left >= 1) options.out           = argv[++i];
+        else if (arg == "--center" && left >= 2) {
+            options.x = atof(argv[++i]);
+            options.y = atof(argv[++i]);
+        }
+        else if (arg == "--size" && left >= 2) {
+            options.width  = atoi(argv[++i]);
+            options.height = atoi(argv[++i]);
+        }
+        else {
+            usage();
+            return 1;
+        }
+    }
+
+    if (options.width <= 0 || options.height <= 0 || options.frames <= 0 || options.tile <= 0 ||
+        options.maxIterations <= 0 || options.workers < 0 || (options.workers == 0 && options.port <= 0)) {
+        usage();
+        return 1;
+    }
+
+    return coordinatorRun(&options);
+}
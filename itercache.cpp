@@ -0,0 +1,175 @@
+#include "itercache.h"
+
+#include <algorithm>
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+static const char ITER_CACHE_MAGIC[4] = {'I', 'T', 'C', '1'};
+static const char ITER_CACHE_EXT[]    = ".itc";
+
+struct IterCacheHeader {
+    char         magic[4];
+    IterCacheKey key;
+    uint32_t     count;     // число значений после заголовка
+};
+
+// FNV-1a по полям ключа, кроме ограничения итераций:
+// один и тот же вид с разными ограничениями попадает в один файл
+static uint64_t hashKey(const IterCacheKey* key) {
+    const int fields[] = {key->formula, key->precision, 0, 0, 0, key->width, key->height};
+    unsigned char bytes[sizeof(fields)] = {};
+    memcpy(bytes, fields, sizeof(fields));
+    memcpy(bytes + 2 * sizeof(int), &key->xC,   sizeof(float));
+    memcpy(bytes + 3 * sizeof(int), &key->yC,   sizeof(float));
+    memcpy(bytes + 4 * sizeof(int), &key->zoom, sizeof(float));
+
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < sizeof(bytes); i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static bool sameView(const IterCacheKey* a, const IterCacheKey* b) {
+    return a->formula   == b->formula   && a->precision == b->precision &&
+           a->width     == b->width     && a->height    == b->height    &&
+           memcmp(&a->xC,   &b->xC,   sizeof(float)) == 0 &&
+           memcmp(&a->yC,   &b->yC,   sizeof(float)) == 0 &&
+           memcmp(&a->zoom, &b->zoom, sizeof(float)) == 0;
+}
+
+static std::string entryPath(const char* dir, const IterCacheKey* key) {
+    char name[32] = {};
+    snprintf(name, sizeof(name), "/%016llx", (unsigned long long)hashKey(key));
+    return std::string(dir) + name + ITER_CACHE_EXT;
+}
+
+bool iterCacheLookup(const char* dir, const IterCacheKey* key, IterCacheView* view) {
+    std::string path = entryPath(dir, key);
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(IterCacheHeader)) {
+        close(fd);
+        return false;
+    }
+
+    void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return false;
+
+    const IterCacheHeader* header = (const IterCacheHeader*)map;
+    size_t count = (size_t)key->width * key->height;
+    if (memcmp(header->magic, ITER_CACHE_MAGIC, sizeof(ITER_CACHE_MAGIC)) != 0 ||
+        !sameView(&header->key, key) || header->count != count ||
+        (size_t)st.st_size != sizeof(IterCacheHeader) + count * sizeof(uint16_t)) {
+        munmap(map, st.st_size);
+        return false;
+    }
+
+    // время изменения файла служит отметкой последнего использования для вытеснения
+    utimensat(AT_FDCWD, path.c_str(), NULL, 0);
+
+    view->iterations    = (const uint16_t*)(header + 1);
+    view->maxIterations = header->key.maxIterations;
+    view->map           = map;
+    view->mapSize       = st.st_size;
+    return true;
+}
+
+void iterCacheRelease(IterCacheView* view) {
+    if (view->map)
+        munmap(view->map, view->mapSize);
+    memset(view, 0, sizeof(*view));
+}
+
+bool iterCacheStore(const char* dir, const IterCacheKey* key, const int* iterations) {
+    if (key->maxIterations > ITER_CACHE_MAX_ITERATIONS)
+        return false;
+
+    mkdir(dir, 0755);
+
+    size_t count = (size_t)key->width * key->height;
+    IterCacheHeader header = {};
+    memcpy(header.magic, ITER_CACHE_MAGIC, sizeof(ITER_CACHE_MAGIC));
+    header.key   = *key;
+    header.count = (uint32_t)count;
+
+    std::vector<uint16_t> data(count);
+    for (size_t i = 0; i < count; i++)
+        data[i] = (uint16_t)iterations[i];
+
+    // запись во временный файл и rename, чтобы читатель не увидел недописанную запись
+    std::string path = entryPath(dir, key);
+    std::string tmp  = path + ".tmp";
+
+    FILE* file = fopen(tmp.c_str(), "wb");
+    if (!file)
+        return false;
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(data.data(), sizeof(uint16_t), count, file) == count;
+    ok = (fclose(file) == 0) && ok;
+
+    if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+        unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+struct IterCacheEntry {
+    std::string path;
+    timespec    used;
+    size_t      size;
+};
+
+void iterCacheEvict(const char* dir, size_t maxBytes) {
+    DIR* d = opendir(dir);
+    if (!d)
+        return;
+
+    std::vector<IterCacheEntry> entries;
+    size_t total = 0;
+
+    const size_t extLen = sizeof(ITER_CACHE_EXT) - 1;
+    while (struct dirent* ent = readdir(d)) {
+        size_t len = strlen(ent->d_name);
+        if (len <= extLen || strcmp(ent->d_name + len - extLen, ITER_CACHE_EXT) != 0)
+            continue;
+
+        std::string path = std::string(dir) + "/" + ent->d_name;
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0)
+            continue;
+
+        IterCacheEntry entry = {path, st.st_mtim, (size_t)st.st_size};
+        entries.push_back(entry);
+        total += entry.size;
+    }
+    closedir(d);
+
+    std::sort(entries.begin(), entries.end(),
+              [](const IterCacheEntry& a, const IterCacheEntry& b) {
+                  if (a.used.tv_sec != b.used.tv_sec)
+                      return a.used.tv_sec < b.used.tv_sec;
+                  return a.used.tv_nsec < b.used.tv_nsec;
+              });
+
+    for (size_t i = 0; i < entries.size() && total > maxBytes; i++) {
+        if (unlink(entries[i].path.c_str()) == 0)
+            total -= entries[i].size;
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef ITERCACHE_H
+#define ITERCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Ключ кэша: все, от чего зависит буфер итераций
+struct IterCacheKey {
+    int   formula;          // 0 - z^2 + c
+    int   precision;        // размер числа с плавающей точкой в байтах
+    float xC;
+    float yC;
+    float zoom;
+    int   width;
+    int   height;
+    int   maxIterations;    // в имя файла не входит, хранится в заголовке
+};
+
+// Отображенная в память запись кэша
+struct IterCacheView {
+    const uint16_t* iterations;     // width * height значений
+    int             maxIterations;  // ограничение, с которым посчитан буфер
+    void*           map;
+    size_t          mapSize;
+};
+
+const int ITER_CACHE_MAX_ITERATIONS = 0xFFFF;
+
+// Ищет запись для вида key с любым ограничением итераций.
+// При успехе view->maxIterations может быть как больше, так и меньше key->maxIterations.
+bool iterCacheLookup(const char* dir, const IterCacheKey* key, IterCacheView* view);
+void iterCacheRelease(IterCacheView* view);
+
+// Сохраняет буфер итераций (width * height значений), посчитанный с key->maxIterations
+bool iterCacheStore(const char* dir, const IterCacheKey* key, const int* iterations);
+
+// Удаляет давно не использованные записи, пока размер кэша больше maxBytes
+void iterCacheEvict(const char* dir, size_t maxBytes);
+
+#endif // ITERCACHE_H
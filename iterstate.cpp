@@ -0,0 +1,218 @@
+#include "iterstate.h"
+
+#include <algorithm>
+#include <immintrin.h>
+#include <string.h>
+
+void iterStateCreate(IterState* state, int width, int height, float radius) {
+    int count = width * height;
+
+    memset(state, 0, sizeof(*state));
+    state->width  = width;
+    state->height = height;
+    state->radius = radius;
+
+    state->cx         = new float[width];
+    state->cy         = new float[height];
+    state->zx         = new float[count];
+    state->zy         = new float[count];
+    state->iterations = new int[count];
+    state->escaped    = new unsigned char[count];
+    state->pending    = new int[count];
+    state->rowIterations = new int[height];
+}
+
+static const size_t ITER_STATE_ALIGN = 64;
+
+static size_t alignUp(size_t bytes) {
+    return (bytes + ITER_STATE_ALIGN - 1) & ~(ITER_STATE_ALIGN - 1);
+}
+
+size_t iterStateBytes(int width, int height) {
+    size_t count = (size_t)width * height;
+    return alignUp(width * sizeof(float)) + alignUp(height * sizeof(float)) +
+           2 * alignUp(count * sizeof(float)) + 2 * alignUp(count * sizeof(int)) +
+           alignUp(count) + alignUp(height * sizeof(int));
+}
+
+void iterStateCreateIn(IterState* state, int width, int height, float radius, void* memory) {
+    size_t count = (size_t)width * height;
+    char*  next  = (char*)memory;
+
+    memset(state, 0, sizeof(*state));
+    state->width  = width;
+    state->height = height;
+    state->radius = radius;
+
+    state->cx            = (float*)next;         next += alignUp(width * sizeof(float));
+    state->cy            = (float*)next;         next += alignUp(height * sizeof(float));
+    state->zx            = (float*)next;         next += alignUp(count * sizeof(float));
+    state->zy            = (float*)next;         next += alignUp(count * sizeof(float));
+    state->iterations    = (int*)next;           next += alignUp(count * sizeof(int));
+    state->pending       = (int*)next;           next += alignUp(count * sizeof(int));
+    state->escaped       = (unsigned char*)next; next += alignUp(count);
+    state->rowIterations = (int*)next;
+}
+
+void iterStateDestroy(IterState* state) {
+    delete[] state->cx;
+    delete[] state->cy;
+    delete[] state->zx;
+    delete[] state->zy;
+    delete[] state->iterations;
+    delete[] state->escaped;
+    delete[] state->pending;
+    delete[] state->rowIterations;
+    memset(state, 0, sizeof(*state));
+}
+
+inline void setView(IterState* state, float xC, float yC, float zoom, int maxIterations) {
+    state->xC   = xC;
+    state->yC   = yC;
+    state->zoom = zoom;
+    state->maxIterations = maxIterations;
+
+    for (int y = 0; y < state->height; y++)
+        state->rowIterations[y] = maxIterations;
+}
+
+void iterStateReset(IterState* state, float xC, float yC, float zoom) {
+    iterStateResetWindow(state, xC, yC, zoom, 0, 0, state->width, state->height);
+}
+
+void iterStateResetWindow(IterState* state, float xC, float yC, float zoom, int x0, int y0, int frameWidth, int frameHeight) {
+    setView(state, xC, yC, zoom, 0);
+
+    for (int x = 0; x < state->width; x++)
+        state->cx[x] = iterPointX(x0 + x, frameWidth, xC, zoom);
+    for (int y = 0; y < state->height; y++)
+        state->cy[y] = iterPointY(y0 + y, frameHeight, yC, zoom);
+
+    for (int y = 0; y < state->height; y++) {
+        for (int x = 0; x < state->width; x++) {
+            int i = y * state->width + x;
+            state->zx[i]         = state->cx[x];
+            state->zy[i]         = state->cy[y];
+            state->iterations[i] = 0;
+            state->escaped[i]    = 0;
+        }
+    }
+}
+
+void iterStateSeed(IterState* state, float xC, float yC, float zoom, const uint16_t* known, int knownMax) {
+    iterStateReset(state, xC, yC, zoom);
+
+    int count = state->width * state->height;
+    for (int i = 0; i < count; i++) {
+        if (known[i] < knownMax) {
+            state->iterations[i] = known[i];
+            state->escaped[i]    = 1;
+        }
+    }
+    setView(state, xC, yC, zoom, knownMax);
+}
+
+void iterStateAdvance(IterState* state, int maxIterations) {
+    iterStateAdvanceRows(state, maxIterations, 0, state->height);
+}
+
+// Дорожки вектора обрабатывают точки из списка pending. Как только точка
+// выходит за радиус или доходит до ограничения, ее состояние записывается
+// обратно, а на освободившуюся дорожку загружается следующая точка,
+// поэтому все четыре дорожки заняты, пока список не кончится.
+void iterStateAdvanceRows(IterState* state, int maxIterations, int y0, int y1) {
+    int pendingCount = 0;
+    for (int y = y0; y < y1; y++) {
+        if (state->rowIterations[y] >= maxIterations)
+            continue;
+        state->rowIterations[y] = maxIterations;
+
+        for (int i = y * state->width; i < (y + 1) * state->width; i++) {
+            if (!state->escaped[i])
+                state->pending[pendingCount++] = i;
+        }
+    }
+
+    state->maxIterations = state->rowIterations[0];
+    for (int y = 1; y < state->height; y++)
+        state->maxIterations = std::min(state->maxIterations, state->rowIterations[y]);
+
+    if (!pendingCount)
+        return;
+
+    alignas(16) float laneX[4]  = {}, laneY[4]  = {};
+    alignas(16) float laneX0[4] = {}, laneY0[4] = {};
+    alignas(16) int   laneN[4]  = {};
+    int laneIdx[4] = {-1, -1, -1, -1};
+
+    __m128  radius = _mm_set_ps1(state->radius);
+    __m128i cap    = _mm_set1_epi32(maxIterations);
+
+    int next = 0, doneMask = 0;
+    while (true) {
+        // запись закончивших точек и загрузка новых на их дорожки
+        int idleMask = 0;
+        for (int lane = 0; lane < 4; lane++) {
+            int i = laneIdx[lane];
+            if (i >= 0) {
+                if (!(doneMask & (1 << lane)))
+                    continue;
+
+                state->zx[i]         = laneX[lane];
+                state->zy[i]         = laneY[lane];
+                state->iterations[i] = laneN[lane];
+                state->escaped[i]    = laneN[lane] < maxIterations;
+                laneIdx[lane] = -1;
+            }
+
+            if (next < pendingCount) {
+                i = state->pending[next++];
+                laneIdx[lane] = i;
+                laneX[lane]   = state->zx[i];
+                laneY[lane]   = state->zy[i];
+                laneX0[lane]  = state->cx[i % state->width];
+                laneY0[lane]  = state->cy[i / state->width];
+                laneN[lane]   = state->iterations[i];
+            }
+            else {
+                // пустая дорожка: z = c = 0 никогда не выходит за радиус
+                laneX[lane] = laneY[lane] = laneX0[lane] = laneY0[lane] = 0;
+                laneN[lane] = 0;
+                idleMask |= 1 << lane;
+            }
+        }
+
+        if (idleMask == 0xF)
+            break;
+
+        __m128  X  = _mm_load_ps(laneX),  Y  = _mm_load_ps(laneY);
+        __m128  X0 = _mm_load_ps(laneX0), Y0 = _mm_load_ps(laneY0);
+        __m128i N  = _mm_load_si128((__m128i*)laneN);
+
+        while (true) {
+            __m128 x2 = _mm_mul_ps(X, X);
+            __m128 y2 = _mm_mul_ps(Y, Y);
+            __m128 xy = _mm_mul_ps(X, Y);
+
+            __m128 r2  = _mm_add_ps(x2, y2);
+            __m128 cmp = _mm_and_ps(_mm_cmple_ps(r2, radius),
+                                    _mm_castsi128_ps(_mm_cmplt_epi32(N, cap)));
+
+            // выходим на перезагрузку, когда закончила хотя бы одна занятая дорожка
+            int mask = _mm_movemask_ps(cmp);
+            if ((mask | idleMask) != 0xF) {
+                doneMask = ~(mask | idleMask) & 0xF;
+                break;
+            }
+
+            N = _mm_sub_epi32(N, _mm_castps_si128(cmp));
+
+            X = _mm_add_ps(_mm_sub_ps(x2, y2), X0);
+            Y = _mm_add_ps(_mm_add_ps(xy, xy), Y0);
+        }
+
+        _mm_store_ps(laneX, X);
+        _mm_store_ps(laneY, Y);
+        _mm_store_si128((__m128i*)laneN, N);
+    }
+}
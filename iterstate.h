@@ -0,0 +1,65 @@
+#ifndef ITERSTATE_H
+#define ITERSTATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Состояние итераций всех точек изображения в виде структуры массивов.
+// Хранит z и число итераций каждой точки, поэтому увеличение ограничения
+// итераций продолжает счет только для точек, дошедших до старого ограничения.
+struct IterState {
+    int    width;
+    int    height;
+    float  radius;
+
+    float  xC;               // вид, для которого посчитано состояние
+    float  yC;
+    float  zoom;
+    int    maxIterations;    // ограничение, до которого доведены все строки
+
+    float*         cx;       // координаты столбцов и строк для текущего вида
+    float*         cy;
+    float*         zx;
+    float*         zy;
+    int*           iterations;
+    unsigned char* escaped;
+    int*           pending;  // индексы точек, для которых продолжается счет
+    int*           rowIterations;  // ограничение, до которого доведена каждая строка
+};
+
+// Координаты точки комплексной плоскости для пикселя (x, y)
+inline float iterPointX(int x, int width, float xC, float zoom) {
+    return (float)x / width * 3.5f * zoom - 2.5f + xC;
+}
+
+inline float iterPointY(int y, int height, float yC, float zoom) {
+    return (float)y / height * 2.0f * zoom - 1.0f + yC;
+}
+
+void iterStateCreate(IterState* state, int width, int height, float radius);
+void iterStateDestroy(IterState* state);
+
+// Размещает массивы состояния в готовом блоке памяти размером iterStateBytes(width, height);
+// такое состояние не освобождается через iterStateDestroy
+size_t iterStateBytes(int width, int height);
+void   iterStateCreateIn(IterState* state, int width, int height, float radius, void* memory);
+
+// Сбрасывает все точки в z = c без итераций
+void iterStateReset(IterState* state, float xC, float yC, float zoom);
+
+// То же для состояния, которое покрывает окно [x0, x0 + width) x [y0, y0 + height)
+// кадра размером frameWidth x frameHeight
+void iterStateResetWindow(IterState* state, float xC, float yC, float zoom, int x0, int y0, int frameWidth, int frameHeight);
+
+// Заполняет состояние из буфера итераций, посчитанного с ограничением knownMax:
+// вышедшие точки берутся как есть, остальные начинают счет заново
+// (до следующего iterStateAdvance их число итераций равно 0, а не knownMax)
+void iterStateSeed(IterState* state, float xC, float yC, float zoom, const uint16_t* known, int knownMax);
+
+// Продолжает счет невышедших точек до maxIterations
+void iterStateAdvance(IterState* state, int maxIterations);
+
+// То же только для строк [y0, y1), чтобы кадр можно было считать полосами
+void iterStateAdvanceRows(IterState* state, int maxIterations, int y0, int y1);
+
+#endif // ITERSTATE_H
@@ -0,0 +1,399 @@
+#include "scheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+static const size_t CACHE_LINE            = 64;
+static const int    TILE_WIDTH            = 64;    // 256 байт RGBA или int на строку плитки
+static const int    TILE_BYTES_PER_PIXEL  = 24;    // состояние точки и результат
+static const size_t DEFAULT_L1_SIZE       = 32 * 1024;
+static const size_t DEFAULT_L2_SIZE       = 1024 * 1024;
+
+void* arenaAlloc(Arena* arena, size_t bytes) {
+    size_t start = (arena->used + CACHE_LINE - 1) & ~(CACHE_LINE - 1);
+    if (start + bytes > arena->size)
+        return NULL;
+
+    arena->used = start + bytes;
+    return arena->base + start;
+}
+
+void arenaReset(Arena* arena) {
+    arena->used = 0;
+}
+
+// Арена потока создается в уже закрепленном потоке, поэтому ее страницы
+// лежат в памяти его узла
+static thread_local Arena threadArena = {};
+
+static size_t cacheSize(int name, size_t fallback) {
+    long size = sysconf(name);
+    return size > 0 ? (size_t)size : fallback;
+}
+
+// Разбор списка номеров (процессоров или узлов) вида "0-3,8-11"
+static std::vector<int> parseCpuList(const char* list) {
+    std::vector<int> cpus;
+    const char* p = list;
+    while (*p) {
+        char* end = NULL;
+        int first = (int)strtol(p, &end, 10);
+        if (end == p)
+            break;
+
+        int last = first;
+        p = end;
+        if (*p == '-') {
+            last = (int)strtol(p + 1, &end, 10);
+            p = end;
+        }
+        for (int cpu = first; cpu <= last; cpu++)
+            cpus.push_back(cpu);
+
+        while (*p == ',' || *p == '\n' || *p == ' ')
+            p++;
+    }
+    return cpus;
+}
+
+// Строка файла sysfs, пустая, если файла нет
+static std::string readSysfs(const char* path) {
+    FILE* file = fopen(path, "r");
+    if (!file)
+        return std::string();
+
+    char text[4096] = {};
+    size_t len = fread(text, 1, sizeof(text) - 1, file);
+    text[len] = '\0';
+    fclose(file);
+    return text;
+}
+
+// Процессоры каждого узла NUMA, доступные процессу. Номера узлов берутся из
+// /sys/devices/system/node/online, в них бывают пропуски. Узлы без доступных
+// процессоров (например, только с памятью) пропускаются. Без
+// /sys/devices/system/node все процессоры считаются одним узлом
+static std::vector<std::vector<int> > detectNodes() {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    sched_getaffinity(0, sizeof(allowed), &allowed);
+
+    std::vector<std::vector<int> > nodes;
+    for (int node : parseCpuList(readSysfs("/sys/devices/system/node/online").c_str())) {
+        char path[64] = {};
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+
+        std::vector<int> cpus;
+        for (int cpu : parseCpuList(readSysfs(path).c_str())) {
+            if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed))
+                cpus.push_back(cpu);
+        }
+        if (!cpus.empty())
+            nodes.push_back(cpus);
+    }
+
+    if (nodes.empty()) {
+        std::vector<int> cpus;
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &allowed))
+                cpus.push_back(cpu);
+        }
+        if (cpus.empty())
+            cpus.push_back(0);
+        nodes.push_back(cpus);
+    }
+    return nodes;
+}
+
+int numaNodeCount() {
+    return (int)detectNodes().size();
+}
+
+// Полоса строк плиток одного узла и счетчик выданных плиток.
+// Счетчики разных узлов лежат в разных строках кэша
+struct alignas(CACHE_LINE) NodeRegion {
+    int              firstTile;
+    int              lastTile;
+    std::atomic<int> next;
+};
+
+struct Worker {
+    TileScheduler* sched;
+    int            node;
+    int            cpu;
+};
+
+struct TileScheduler {
+    int width;
+    int height;
+    int tileWidth;
+    int tileHeight;
+    int tilesX;
+    int tilesY;
+
+    size_t arenaSize;
+
+    std::vector<NodeRegion*> regions;
+    std::vector<Worker>      workers;
+    std::vector<std::thread> threads;
+
+    std::mutex              lock;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    unsigned                generation;
+    int                     running;
+    bool                    stop;
+    int                     started;    // сколько потоков создали арену
+    bool                    failed;     // арену хотя бы одного потока выделить не удалось
+
+    TileFunc func;
+    void*    ctx;
+    bool     steal;
+};
+
+static void tileRect(const TileScheduler* sched, int index, Tile* tile) {
+    int tx = index % sched->tilesX;
+    int ty = index / sched->tilesX;
+
+    tile->x0 = tx * sched->tileWidth;
+    tile->y0 = ty * sched->tileHeight;
+    tile->x1 = std::min(tile->x0 + sched->tileWidth,  sched->width);
+    tile->y1 = std::min(tile->y0 + sched->tileHeight, sched->height);
+}
+
+static bool claimTile(NodeRegion* region, int* index) {
+    int i = region->next.fetch_add(1, std::memory_order_relaxed);
+    if (i >= region->lastTile)
+        return false;
+
+    *index = i;
+    return true;
+}
+
+static void runTiles(TileScheduler* sched, int node) {
+    int nodeCount = (int)sched->regions.size();
+
+    // сначала своя полоса, затем (если разрешено) чужие, начиная с соседнего узла
+    for (int k = 0; k < (sched->steal ? nodeCount : 1); k++) {
+        NodeRegion* region = sched->regions[(node + k) % nodeCount];
+
+        int index = 0;
+        while (claimTile(region, &index)) {
+            Tile tile;
+            tileRect(sched, index, &tile);
+
+            arenaReset(&threadArena);
+            sched->func(&tile, &threadArena, sched->ctx);
+        }
+    }
+}
+
+static void workerLoop(Worker* worker) {
+    TileScheduler* sched = worker->sched;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(worker->cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+
+    threadArena.base = (char*)aligned_alloc(CACHE_LINE, sched->arenaSize);
+    threadArena.size = sched->arenaSize;
+    threadArena.used = 0;
+    if (threadArena.base)
+        memset(threadArena.base, 0, threadArena.size);
+
+    {
+        std::lock_guard<std::mutex> guard(sched->lock);
+        sched->started++;
+        sched->failed = sched->failed || !threadArena.base;
+        sched->finished.notify_one();
+    }
+    if (!threadArena.base) {
+        threadArena = Arena();
+        return;
+    }
+
+    unsigned seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> guard(sched->lock);
+            sched->wake.wait(guard, [&] { return sched->stop || sched->generation != seen; });
+            if (sched->stop)
+                break;
+            seen = sched->generation;
+        }
+
+        runTiles(sched, worker->node);
+
+        std::lock_guard<std::mutex> guard(sched->lock);
+        if (--sched->running == 0)
+            sched->finished.notify_one();
+    }
+
+    free(threadArena.base);
+    threadArena = Arena();
+}
+
+static void runJob(TileScheduler* sched, TileFunc func, void* ctx, bool steal) {
+    std::unique_lock<std::mutex> guard(sched->lock);
+
+    for (NodeRegion* region : sched->regions)
+        region->next.store(region->firstTile, std::memory_order_relaxed);
+
+    sched->func    = func;
+    sched->ctx     = ctx;
+    sched->steal   = steal;
+    sched->running = (int)sched->workers.size();
+    sched->generation++;
+    sched->wake.notify_all();
+
+    sched->finished.wait(guard, [&] { return sched->running == 0; });
+}
+
+TileScheduler* schedulerCreate(int width, int height, int nodes, int threads) {
+    std::vector<std::vector<int> > topology = detectNodes();
+    if (nodes > 0 && nodes < (int)topology.size())
+        topology.resize(nodes);
+
+    TileScheduler* sched = new TileScheduler();
+    sched->width  = width;
+    sched->height = height;
+
+    // плитка вместе с временным состоянием помещается в L1,
+    // арена потока - в его долю L2
+    size_t l1 = cacheSize(_SC_LEVEL1_DCACHE_SIZE, DEFAULT_L1_SIZE);
+    size_t l2 = cacheSize(_SC_LEVEL2_CACHE_SIZE,  DEFAULT_L2_SIZE);
+
+    sched->tileWidth  = TILE_WIDTH;
+    sched->tileHeight = 4;
+    while (sched->tileHeight < 64 &&
+           (size_t)TILE_WIDTH * sched->tileHeight * 2 * TILE_BYTES_PER_PIXEL <= l1)
+        sched->tileHeight *= 2;
+
+    sched->arenaSize = std::max(l2 / 2, (size_t)TILE_WIDTH * sched->tileHeight * TILE_BYTES_PER_PIXEL * 2);
+    sched->arenaSize = (sched->arenaSize + CACHE_LINE - 1) & ~(CACHE_LINE - 1);
+
+    sched->tilesX = (width  + sched->tileWidth  - 1) / sched->tileWidth;
+    sched->tilesY = (height + sched->tileHeight - 1) / sched->tileHeight;
+
+    for (int node = 0; node < (int)topology.size(); node++) {
+        int count = threads > 0 ? threads : (int)topology[node].size();
+        for (int t = 0; t < count; t++) {
+            Worker worker = {sched, node, topology[node][t % topology[node].size()]};
+            sched->workers.push_back(worker);
+        }
+    }
+
+    // строки плиток делятся между узлами пропорционально числу их потоков
+    int totalWorkers = (int)sched->workers.size();
+    int row = 0, assigned = 0;
+    for (int node = 0; node < (int)topology.size(); node++) {
+        int count = threads > 0 ? threads : (int)topology[node].size();
+        assigned += count;
+
+        int lastRow = sched->tilesY * assigned / totalWorkers;
+
+        NodeRegion* region = new NodeRegion();
+        region->firstTile = row * sched->tilesX;
+        region->lastTile  = lastRow * sched->tilesX;
+        region->next.store(region->firstTile);
+        sched->regions.push_back(region);
+
+        row = lastRow;
+    }
+
+    sched->generation = 0;
+    sched->running    = 0;
+    sched->stop       = false;
+    sched->started    = 0;
+    sched->failed     = false;
+
+    for (size_t i = 0; i < sched->workers.size(); i++)
+        sched->threads.push_back(std::thread(workerLoop, &sched->workers[i]));
+
+    bool failed = false;
+    {
+        std::unique_lock<std::mutex> guard(sched->lock);
+        sched->finished.wait(guard, [&] { return sched->started == (int)sched->workers.size(); });
+        failed = sched->failed;
+    }
+    if (failed) {
+        schedulerDestroy(sched);
+        return NULL;
+    }
+
+    return sched;
+}
+
+void schedulerDestroy(TileScheduler* sched) {
+    {
+        std::lock_guard<std::mutex> guard(sched->lock);
+        sched->stop = true;
+        sched->wake.notify_all();
+    }
+    for (std::thread& thread : sched->threads)
+        thread.join();
+
+    for (NodeRegion* region : sched->regions)
+        delete region;
+    delete sched;
+}
+
+struct TouchJob {
+    char*  frame;
+    size_t rowBytes;
+    size_t bytesPerPixel;
+};
+
+static void touchTile(const Tile* tile, Arena*, void* ctx) {
+    TouchJob* job = (TouchJob*)ctx;
+    for (int y = tile->y0; y < tile->y1; y++)
+        memset(job->frame + y * job->rowBytes + tile->x0 * job->bytesPerPixel, 0,
+               (tile->x1 - tile->x0) * job->bytesPerPixel);
+}
+
+void* schedulerAllocFrame(TileScheduler* sched, size_t bytesPerPixel) {
+    size_t bytes = (size_t)sched->width * sched->height * bytesPerPixel;
+
+    // mmap не касается страниц, их размещает первая запись
+    void* frame = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (frame == MAP_FAILED)
+        return NULL;
+
+    TouchJob job = {(char*)frame, sched->width * bytesPerPixel, bytesPerPixel};
+    runJob(sched, touchTile, &job, false);
+    return frame;
+}
+
+void schedulerFreeFrame(TileScheduler* sched, void* frame, size_t bytesPerPixel) {
+    munmap(frame, (size_t)sched->width * sched->height * bytesPerPixel);
+}
+
+void schedulerRun(TileScheduler* sched, TileFunc func, void* ctx) {
+    runJob(sched, func, ctx, true);
+}
+
+int schedulerThreads(const TileScheduler* sched) {
+    return (int)sched->workers.size();
+}
+
+int schedulerNodes(const TileScheduler* sched) {
+    return (int)sched->regions.size();
+}
+
+void schedulerTileSize(const TileScheduler* sched, int* tileWidth, int* tileHeight) {
+    *tileWidth  = sched->tileWidth;
+    *tileHeight = sched->tileHeight;
+}
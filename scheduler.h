@@ -0,0 +1,51 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stddef.h>
+
+// Линейный аллокатор для временных данных одного потока
+struct Arena {
+    char*  base;
+    size_t size;
+    size_t used;
+};
+
+// Выделяет память с выравниванием по строке кэша, NULL если места не хватает
+void* arenaAlloc(Arena* arena, size_t bytes);
+void  arenaReset(Arena* arena);
+
+// Плитка изображения [x0, x1) x [y0, y1)
+struct Tile {
+    int x0, y0;
+    int x1, y1;
+};
+
+// Считает одну плитку. arena принадлежит потоку и сбрасывается перед каждой плиткой
+typedef void (*TileFunc)(const Tile* tile, Arena* arena, void* ctx);
+
+struct TileScheduler;
+
+// Создает потоки, закрепленные за ядрами. Каждому узлу NUMA (сокету) достается
+// непрерывная полоса строк изображения, плитки внутри нее берут потоки этого узла.
+// nodes - сколько узлов использовать (0 - все), threads - сколько потоков на узел
+// (0 - по одному на каждое ядро узла). NULL, если не удалось выделить арены потоков
+TileScheduler* schedulerCreate(int width, int height, int nodes, int threads);
+void           schedulerDestroy(TileScheduler* sched);
+
+// Буфер width * height * bytesPerPixel. Страницы каждой полосы впервые
+// записываются потоками ее узла, поэтому лежат в памяти этого узла
+void* schedulerAllocFrame(TileScheduler* sched, size_t bytesPerPixel);
+void  schedulerFreeFrame(TileScheduler* sched, void* frame, size_t bytesPerPixel);
+
+// Считает все плитки и ждет окончания. Потоки, закончившие свою полосу,
+// забирают оставшиеся плитки других узлов
+void schedulerRun(TileScheduler* sched, TileFunc func, void* ctx);
+
+int  schedulerThreads(const TileScheduler* sched);
+int  schedulerNodes(const TileScheduler* sched);
+void schedulerTileSize(const TileScheduler* sched, int* tileWidth, int* tileHeight);
+
+// Число узлов NUMA, на которых процессу разрешено работать
+int  numaNodeCount();
+
+#endif // SCHEDULER_H
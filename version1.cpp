@@ -1,5 +1,6 @@
 #include <SFML/Graphics.hpp>
 #include <cmath>
+#include <x86intrin.h>
 #include <string>
 
 const int   MAX_ITERATIONS = 256;
@@ -1,6 +1,7 @@
 #include <SFML/Graphics.hpp> // Подключение заголовочного файла SFML для работы с графикой
 #include <cmath> // Подключение заголовочного файла для математических функций
 #include <string> // Подключение заголовочного файла для работы со строками
+#include <x86intrin.h> // Подключение __rdtsc для замеров времени
 
 const int   MAX_ITERATIONS = 256;
 const float RADIUS         = 100.0f;
@@ -140,6 +141,29 @@ inline void handleKeyPress(sf::RenderWindow& window, float& xC, float& yC, float
     }
 }
 
+// Функция подсчитывает FPS и выводит его в окно
+inline void writeFPS(sf::RenderWindow& window, sf::Text& fpsText, sf::Clock& gameClock, int& frames, int& cntForFps, unsigned long long& all_fps) {
+    frames++;
+    sf::Time elapsed = gameClock.getElapsedTime();
+    if (elapsed.asSeconds() >= 1.0f) {
+        float fps = frames / elapsed.asSeconds();
+        all_fps += fps;
+
+        #ifdef TIME_MEASURE
+        if (cntForFps == LIMIT) {
+            printf("FPS: %llu\n", all_fps / LIMIT);
+        }
+        #endif
+        std::string fpsStr = "FPS: " + std::to_string(static_cast<int>(fps));
+
+        fpsText.setString(fpsStr);
+        frames = 0;
+        gameClock.restart();
+    }
+
+    window.draw(fpsText);
+}
+
 inline void processEvents(sf::RenderWindow& window, float& xC, float& yC, float& zoom, sf::Image& image, sf::Texture& texture, sf::Sprite& sprite, sf::Text& fpsText, sf::Clock& gameClock, int& frames) {
     int cntForTick = 0, cntForFps = 0;
     unsigned long long all_time = 0, all_fps = 0;
@@ -176,10 +200,10 @@ inline void processEvents(sf::RenderWindow& window, float& xC, float& yC, float&
         unsigned long long end = __rdtsc();
         unsigned long long elapsedTime = end - start;
         cntForTick++;
+        all_time += elapsedTime;
         #endif
 
         cntForFps++;
-        all_time += elapsedTime;
 
         #ifdef TIME_MEASURE
         if (cntForTick == LIMIT) {
@@ -195,8 +219,6 @@ inline void processEvents(sf::RenderWindow& window, float& xC, float& yC, float&
 
         window.display();
     }
-
-    return 0;
 }
 
 inline void initialize(sf::RenderWindow& window, sf::Image& image, sf::Texture& texture, sf::Sprite& sprite, sf::Text& fpsText, sf::Font& font) {
@@ -91,7 +91,7 @@ inline void mandelbrot(const __m128 X0, const __m128 Y0, volatile __m128& color)
         int mask = _mm_movemask_ps(cmp);
         if (!mask) break;
 
-        color = _mm_sub_epi32(color, _mm_castps_si128(cmp));
+        color = _mm_castsi128_ps(_mm_sub_epi32(_mm_castps_si128(color), _mm_castps_si128(cmp)));
 
         X = _mm_add_ps(_mm_sub_ps(x2, y2), X0);
         Y = _mm_add_ps(_mm_add_ps(xy, xy), Y0);
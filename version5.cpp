@@ -0,0 +1,675 @@
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <immintrin.h>
+#include <mutex>
+#include <string.h>
+#include <thread>
+
+#include "itercache.h"
+#include "iterstate.h"
+
+const int    WIDTH          = 800;
+const int    HEIGHT         = 600;
+const float  ZOOM_FACTOR    = 1.1f;
+const float  MOVE_FACTOR    = 0.1f;
+const int    MAX_ITERATIONS = 256;
+const float  RADIUS         = 100.0f;
+const int    LIMIT          = 100.0;
+const float  DE_SHADE_WIDTH = 4.0f;   // ширина (в пикселях) затемнения у границы множества
+const int    MIN_ITERATIONS = 16;
+const int    BAND_HEIGHT    = 8;      // высота полосы, которую фоновый поток считает за раз
+const int    MIN_DRAG       = 8;      // меньший прямоугольник считается щелчком
+const int    FRAME_LIMIT    = 60;
+
+const char*  CACHE_DIR       = ".mandelbrot_cache";
+const size_t CACHE_MAX_BYTES = 256 * 1024 * 1024;
+const int    CACHE_SETTLE_MS = 500;   // вид записывается в кэш, если он не менялся столько миллисекунд
+
+// #define TIME_MEASURE
+#define ITER_CACHE
+
+// Вид на множество и режим отрисовки
+struct View {
+    float xC;
+    float yC;
+    float zoom;
+    int   maxIterations;
+    bool  distMode;
+};
+
+// Прямоугольник, выделяемый мышью для приближения
+struct Drag {
+    bool active;
+    int  x0, y0;
+    int  x1, y1;
+};
+
+// Кадр в формате RGBA и вид, для которого он посчитан
+struct Frame {
+    sf::Uint8* pixels;
+    bool*      rowDone;
+    View       view;
+    bool       valid;
+};
+
+// Общее состояние основного потока и фонового потока отрисовки
+struct Renderer {
+    std::mutex              lock;
+    std::condition_variable wake;
+    std::thread             worker;
+
+    View      request;
+    unsigned  generation;   // растет при каждом новом запросе
+    bool      stop;
+    bool      updated;      // фоновый поток досчитал новые строки
+
+    Frame     progress;     // кадр, который сейчас считается
+    Frame     complete;     // последний полностью посчитанный кадр
+
+    IterState state;        // используется только фоновым потоком
+};
+
+void writeFPS(sf::RenderWindow* window, sf::Text* fpsText, sf::Clock* gameClock, int* frames, int* cntForFps, unsigned long long* all_fps) {
+    (*frames)++;
+    sf::Time elapsed = gameClock->getElapsedTime();
+    if (elapsed.asSeconds() >= 1.0f) {
+        float fps = (*frames) / gameClock->getElapsedTime().asSeconds();
+
+        #ifndef CNT_FPS
+        *all_fps += fps;
+        #endif
+
+        #ifdef TIME_MEASURE
+        if (*cntForFps == LIMIT) {
+            printf("FPS: %llu\n", *all_fps / LIMIT);
+        }
+        #endif
+        std::string fpsStr = "FPS: " + std::to_string(static_cast<int>(fps));
+
+        fpsText->setString(fpsStr);
+        (*frames) = 0;
+        gameClock->restart();
+    }
+
+    window->draw(*fpsText);
+}
+
+
+// Приближение в factor раз, при котором точка под курсором остается на месте
+inline void zoomAt(View* view, int x, int y, float factor) {
+    float zoom = view->zoom * factor;
+    view->xC += (float)x / WIDTH  * 3.5f * (view->zoom - zoom);
+    view->yC += (float)y / HEIGHT * 2.0f * (view->zoom - zoom);
+    view->zoom = zoom;
+}
+
+// Приближение, при котором выделенный прямоугольник заполняет экран
+inline void zoomToRect(View* view, const Drag* drag) {
+    int left   = std::min(drag->x0, drag->x1), right  = std::max(drag->x0, drag->x1);
+    int top    = std::min(drag->y0, drag->y1), bottom = std::max(drag->y0, drag->y1);
+    if (right - left < MIN_DRAG || bottom - top < MIN_DRAG)
+        return;
+
+    float zoom = view->zoom * std::max((float)(right - left) / WIDTH, (float)(bottom - top) / HEIGHT);
+    float cx   = (left + right) * 0.5f / WIDTH  * 3.5f * view->zoom - 2.5f + view->xC;
+    float cy   = (top + bottom) * 0.5f / HEIGHT * 2.0f * view->zoom - 1.0f + view->yC;
+
+    view->xC   = cx + 2.5f - 1.75f * zoom;
+    view->yC   = cy + 1.0f - zoom;
+    view->zoom = zoom;
+}
+
+inline void handleKeyPress(sf::RenderWindow* window, View* view, Drag* drag) {
+    sf::Event event;
+    while (window->pollEvent(event)) {
+        if (event.type == sf::Event::Closed)
+            window->close();
+        else if (event.type == sf::Event::KeyPressed) {
+            switch (event.key.code) {
+                case sf::Keyboard::Right:
+                    view->xC += MOVE_FACTOR; // Move image right
+                    break;
+                case sf::Keyboard::Left:
+                    view->xC -= MOVE_FACTOR; // Move image left
+                    break;
+                case sf::Keyboard::Up:
+                    view->yC -= MOVE_FACTOR; // Move image up
+                    break;
+                case sf::Keyboard::Down:
+                    view->yC += MOVE_FACTOR; // Move image down
+                    break;
+                case sf::Keyboard::Equal:
+                    view->zoom /= ZOOM_FACTOR; // Zoom in
+                    break;
+                case sf::Keyboard::Dash:
+                    view->zoom *= ZOOM_FACTOR; // Zoom out
+                    break;
+                case sf::Keyboard::RBracket:
+                    if (view->maxIterations * 2 <= ITER_CACHE_MAX_ITERATIONS)
+                        view->maxIterations *= 2; // More iterations
+                    break;
+                case sf::Keyboard::LBracket:
+                    if (view->maxIterations / 2 >= MIN_ITERATIONS)
+                        view->maxIterations /= 2; // Fewer iterations
+                    break;
+                case sf::Keyboard::D:
+                    view->distMode = !view->distMode; // Toggle distance estimation
+                    break;
+                default:
+                    break;
+            }
+        }
+        else if (event.type == sf::Event::MouseWheelScrolled) {
+            if (event.mouseWheelScroll.wheel == sf::Mouse::VerticalWheel)
+                zoomAt(view, event.mouseWheelScroll.x, event.mouseWheelScroll.y,
+                       powf(ZOOM_FACTOR, -event.mouseWheelScroll.delta));
+        }
+        else if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
+            drag->active = true;
+            drag->x0 = drag->x1 = event.mouseButton.x;
+            drag->y0 = drag->y1 = event.mouseButton.y;
+        }
+        else if (event.type == sf::Event::MouseMoved && drag->active) {
+            drag->x1 = event.mouseMove.x;
+            drag->y1 = event.mouseMove.y;
+        }
+        else if (event.type == sf::Event::MouseButtonReleased && event.mouseButton.button == sf::Mouse::Left && drag->active) {
+            drag->active = false;
+            zoomToRect(view, drag);
+        }
+    }
+}
+
+// Функция для оценки расстояния до границы множества (distance estimation).
+// Вместе с z = X + iY в регистрах ведется производная dz = DX + iDY по c:
+// dz' = 2 * z * dz + 1. В момент выхода точки за радиус z и dz запоминаются,
+// после цикла расстояние считается как 0.5 * |z| * ln|z| / |dz|.
+// Для точек внутри множества dist = 0.
+inline void mandelbrotDE(const __m128 X0, const __m128 Y0, __m128i& color, __m128& dist, int maxIterations) {
+    __m128 X  = X0;                // z1 = c
+    __m128 Y  = Y0;
+    __m128 DX = _mm_set_ps1(1);    // dz1 = 1
+    __m128 DY = _mm_set_ps1(0);
+    __m128 radius = _mm_set_ps1(RADIUS);
+    __m128 one    = _mm_set_ps1(1);
+
+    // z и dz на момент выхода за радиус
+    __m128 ZX = _mm_set_ps1(0), ZY = _mm_set_ps1(0);
+    __m128 EX = _mm_set_ps1(1), EY = _mm_set_ps1(0);
+
+    __m128 prevCmp  = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    int    prevMask = 0xF;
+
+    for (int n = 0; n < maxIterations; n++) {
+        __m128 x2 = _mm_mul_ps(X, X);
+        __m128 y2 = _mm_mul_ps(Y, Y);
+        __m128 xy = _mm_mul_ps(X, Y);
+
+        __m128 r2 = _mm_add_ps(x2, y2);
+        __m128 cmp = _mm_cmple_ps(r2, radius);
+
+        int mask = _mm_movemask_ps(cmp);
+
+        // маска меняется не чаще четырех раз, поэтому запоминание z и dz
+        // вынесено из основного пути цикла
+        if (mask != prevMask) {
+            __m128 esc = _mm_andnot_ps(cmp, prevCmp);
+            ZX = _mm_or_ps(_mm_and_ps(esc, X),  _mm_andnot_ps(esc, ZX));
+            ZY = _mm_or_ps(_mm_and_ps(esc, Y),  _mm_andnot_ps(esc, ZY));
+            EX = _mm_or_ps(_mm_and_ps(esc, DX), _mm_andnot_ps(esc, EX));
+            EY = _mm_or_ps(_mm_and_ps(esc, DY), _mm_andnot_ps(esc, EY));
+            prevCmp  = cmp;
+            prevMask = mask;
+        }
+        if (!mask) break;
+
+        color = _mm_sub_epi32(color, _mm_castps_si128(cmp));
+
+        // dz' = 2 * (X * DX - Y * DY) + 1 + 2i * (X * DY + Y * DX)
+        __m128 dx = _mm_sub_ps(_mm_mul_ps(X, DX), _mm_mul_ps(Y, DY));
+        __m128 dy = _mm_add_ps(_mm_mul_ps(X, DY), _mm_mul_ps(Y, DX));
+        DX = _mm_add_ps(_mm_add_ps(dx, dx), one);
+        DY = _mm_add_ps(dy, dy);
+
+        X = _mm_add_ps(_mm_sub_ps(x2, y2), X0);
+        Y = _mm_add_ps(_mm_add_ps(xy, xy), Y0);
+    }
+
+    // dist = 0.25 * ln(|z|^2) * sqrt(|z|^2 / |dz|^2)
+    __m128 r2  = _mm_add_ps(_mm_mul_ps(ZX, ZX), _mm_mul_ps(ZY, ZY));
+    __m128 dz2 = _mm_add_ps(_mm_mul_ps(EX, EX), _mm_mul_ps(EY, EY));
+    __m128 q   = _mm_sqrt_ps(_mm_div_ps(r2, dz2));
+    __m128 outside = _mm_cmpgt_ps(r2, radius);
+
+    float r2_f[4] = {}, q_f[4] = {};
+    _mm_storeu_ps(r2_f, r2);
+    _mm_storeu_ps(q_f, q);
+    for (int i = 0; i < 4; i++)
+        q_f[i] *= 0.25f * logf(r2_f[i]);
+
+    dist = _mm_and_ps(outside, _mm_loadu_ps(q_f));
+}
+
+inline __m128 pointsX(int x, float xC, float zoom) {
+    return _mm_set_ps(iterPointX(x + 3, WIDTH, xC, zoom),
+                      iterPointX(x + 2, WIDTH, xC, zoom),
+                      iterPointX(x + 1, WIDTH, xC, zoom),
+                      iterPointX(x + 0, WIDTH, xC, zoom));
+}
+
+inline __m128 pointsY(int y, float yC, float zoom) {
+    return _mm_set_ps1(iterPointY(y, HEIGHT, yC, zoom));
+}
+
+inline bool sameView(const View* a, const View* b) {
+    return a->xC == b->xC && a->yC == b->yC && a->zoom == b->zoom;
+}
+
+inline bool sameRequest(const View* a, const View* b) {
+    return sameView(a, b) && a->maxIterations == b->maxIterations && a->distMode == b->distMode;
+}
+
+// Для того же вида состояние сохраняется, и при увеличении ограничения итераций
+// счет продолжается только для точек, дошедших до старого ограничения.
+// Для нового вида состояние берется из кэша на диске, если он включен.
+// При замерах каждый кадр считается заново от z = c.
+inline void prepareState(IterState* state, const View* view) {
+    #ifdef TIME_MEASURE
+    iterStateReset(state, view->xC, view->yC, view->zoom);
+    #else
+    if (state->xC == view->xC && state->yC == view->yC && state->zoom == view->zoom)
+        return;
+
+    #ifdef ITER_CACHE
+    IterCacheKey  key  = {0, (int)sizeof(float), view->xC, view->yC, view->zoom, WIDTH, HEIGHT, view->maxIterations};
+    IterCacheView entry = {};
+    if (iterCacheLookup(CACHE_DIR, &key, &entry)) {
+        iterStateSeed(state, view->xC, view->yC, view->zoom, entry.iterations, entry.maxIterations);
+        iterCacheRelease(&entry);
+        return;
+    }
+    #endif
+
+    iterStateReset(state, view->xC, view->yC, view->zoom);
+    #endif
+}
+
+inline void storeState(const IterState* state, const View* view) {
+    #ifdef ITER_CACHE
+    IterCacheKey key = {0, (int)sizeof(float), view->xC, view->yC, view->zoom, WIDTH, HEIGHT, state->maxIterations};
+    if (iterCacheStore(CACHE_DIR, &key, state->iterations))
+        iterCacheEvict(CACHE_DIR, CACHE_MAX_BYTES);
+    #endif
+}
+
+inline void setPixel(sf::Uint8* pixels, int x, int y, sf::Uint8 r, sf::Uint8 g, sf::Uint8 b) {
+    sf::Uint8* pixel = pixels + 4 * (y * WIDTH + x);
+    pixel[0] = r;
+    pixel[1] = g;
+    pixel[2] = b;
+    pixel[3] = 255;
+}
+
+inline void drawIterations(sf::Uint8* pixels, const IterState* state, int maxIterations, int y0, int y1) {
+    for (int y = y0; y < y1; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            int i = y * WIDTH + x;
+            int n = state->escaped[i] ? std::min(state->iterations[i], maxIterations) : maxIterations;
+            setPixel(pixels, x, y, (n * 6) % 256, 0, (n * 10) % 256);
+        }
+    }
+}
+
+inline void drawDistance(sf::Uint8* pixels, const View* view, int y0, int y1) {
+    float pixelSize = 3.5f * view->zoom / WIDTH;
+
+    for (int y = y0; y < y1; y++) {
+        for (int x = 0; x < WIDTH; x += 4) {
+            __m128i color = _mm_setzero_si128();
+            __m128  dist  = _mm_setzero_ps();
+            mandelbrotDE(pointsX(x, view->xC, view->zoom), pointsY(y, view->yC, view->zoom), color, dist, view->maxIterations);
+
+            // раскраска не отключается при TIME_MEASURE: без нее -O3 выбрасывает весь расчет
+            int*   color_int = (int*)(&color);
+            float* dist_f    = (float*)(&dist);
+            for (int i = 0; i < 4; i++) {
+                // у границы цвет затемняется пропорционально расстоянию в пикселях,
+                // что дает сглаженные нити без суперсэмплинга
+                float shade = dist_f[i] / pixelSize / DE_SHADE_WIDTH;
+                if (shade > 1.0f) shade = 1.0f;
+
+                setPixel(pixels, x + i, y, (sf::Uint8)((color_int[i] * 6)  % 256 * shade), 0,
+                                           (sf::Uint8)((color_int[i] * 10) % 256 * shade));
+            }
+        }
+    }
+}
+
+// Для каждого столбца (строки) вида view номер столбца (строки) кадра с видом from,
+// который попадает в ту же точку, или -1, если точка вне кадра
+inline void reprojectMap(int* srcX, int* srcY, const View* view, const View* from) {
+    float scale = view->zoom / from->zoom;
+    float offX  = (view->xC - from->xC) * WIDTH  / (3.5f * from->zoom);
+    float offY  = (view->yC - from->yC) * HEIGHT / (2.0f * from->zoom);
+
+    for (int x = 0; x < WIDTH; x++) {
+        float sx = x * scale + offX;
+        srcX[x] = (sx >= 0 && sx < WIDTH) ? (int)sx : -1;
+    }
+    for (int y = 0; y < HEIGHT; y++) {
+        float sy = y * scale + offY;
+        srcY[y] = (sy >= 0 && sy < HEIGHT) ? (int)sy : -1;
+    }
+}
+
+// Переносит посчитанные строки кадра frame в буфер screen для вида view
+// (масштабирование по ближайшему соседу). Остальные пиксели screen не меняются.
+inline void reproject(sf::Uint8* screen, const View* view, const Frame* frame) {
+    if (!frame->valid)
+        return;
+
+    int srcX[WIDTH], srcY[HEIGHT];
+    reprojectMap(srcX, srcY, view, &frame->view);
+
+    for (int y = 0; y < HEIGHT; y++) {
+        if (srcY[y] < 0 || !frame->rowDone[srcY[y]])
+            continue;
+
+        const sf::Uint8* src = frame->pixels + 4 * srcY[y] * WIDTH;
+        sf::Uint8*       dst = screen + 4 * y * WIDTH;
+        for (int x = 0; x < WIDTH; x++) {
+            if (srcX[x] >= 0)
+                memcpy(dst + 4 * x, src + 4 * srcX[x], 4);
+        }
+    }
+}
+
+// Порядок полос для счета: сначала открывшиеся области, которых нет в прошлом
+// кадре, затем области, растянутые из прошлого кадра при приближении,
+// затем от центра экрана к краям
+inline int bandOrder(int* order, const View* view, const Frame* previous) {
+    int bandCount = (HEIGHT + BAND_HEIGHT - 1) / BAND_HEIGHT;
+    int uncovered[(HEIGHT + BAND_HEIGHT - 1) / BAND_HEIGHT] = {};
+    int magnified[(HEIGHT + BAND_HEIGHT - 1) / BAND_HEIGHT] = {};
+
+    if (previous->valid) {
+        int srcX[WIDTH], srcY[HEIGHT];
+        reprojectMap(srcX, srcY, view, &previous->view);
+
+        int coveredColumns = 0;
+        for (int x = 0; x < WIDTH; x++)
+            coveredColumns += srcX[x] >= 0;
+
+        // при приближении (масштаб reprojectMap меньше 1) один пиксель прошлого
+        // кадра растягивается на несколько, и такие точки нужно досчитать
+        bool zoomIn = view->zoom < previous->view.zoom;
+
+        for (int y = 0; y < HEIGHT; y++) {
+            uncovered[y / BAND_HEIGHT] += srcY[y] >= 0 ? WIDTH - coveredColumns : WIDTH;
+            if (zoomIn && srcY[y] >= 0)
+                magnified[y / BAND_HEIGHT] += coveredColumns;
+        }
+    }
+
+    for (int b = 0; b < bandCount; b++)
+        order[b] = b;
+
+    int center = bandCount / 2;
+    std::stable_sort(order, order + bandCount, [&](int a, int b) {
+        if (uncovered[a] != uncovered[b])
+            return uncovered[a] > uncovered[b];
+        if (magnified[a] != magnified[b])
+            return magnified[a] > magnified[b];
+        return abs(a - center) < abs(b - center);
+    });
+    return bandCount;
+}
+
+// Фоновый поток: считает кадр для последнего запрошенного вида полосами и
+// бросает работу, как только вид снова меняется
+inline void renderLoop(Renderer* renderer) {
+    unsigned done = 0;
+
+    // при замерах тот же вид пересчитывается непрерывно
+    #ifdef TIME_MEASURE
+    bool continuous = true;
+    #else
+    bool continuous = false;
+    #endif
+
+    #ifdef TIME_MEASURE
+    int cntForTick = 0;
+    unsigned long long all_time = 0;
+    #endif
+
+    // посчитанный вид, который еще не записан в кэш
+    bool unsaved = false;
+    View unsavedView;
+
+    while (true) {
+        View     view;
+        unsigned generation;
+        int      order[(HEIGHT + BAND_HEIGHT - 1) / BAND_HEIGHT];
+        int      bandCount;
+        {
+            std::unique_lock<std::mutex> guard(renderer->lock);
+            auto changed = [&] { return continuous || renderer->stop || renderer->generation != done; };
+
+            // в кэш попадают только виды, на которых пользователь остановился,
+            // а промежуточные виды плавного приближения пропускаются
+            if (unsaved && !renderer->wake.wait_for(guard, std::chrono::milliseconds(CACHE_SETTLE_MS), changed)) {
+                guard.unlock();
+                storeState(&renderer->state, &unsavedView);
+                guard.lock();
+            }
+            unsaved = false;
+
+            renderer->wake.wait(guard, changed);
+            if (renderer->stop)
+                return;
+
+            view       = renderer->request;
+            generation = renderer->generation;
+            bandCount  = bandOrder(order, &view, &renderer->complete);
+
+            renderer->progress.view  = view;
+            renderer->progress.valid = true;
+            memset(renderer->progress.rowDone, 0, HEIGHT * sizeof(bool));
+        }
+
+        #ifdef TIME_MEASURE
+        unsigned long long start = __rdtsc();
+        #endif
+
+        int before = 0;
+        if (!view.distMode) {
+            prepareState(&renderer->state, &view);
+            before = renderer->state.maxIterations;
+        }
+
+        bool cancelled = false;
+        for (int b = 0; b < bandCount && !cancelled; b++) {
+            int y0 = order[b] * BAND_HEIGHT;
+            int y1 = std::min(y0 + BAND_HEIGHT, HEIGHT);
+
+            if (view.distMode)
+                drawDistance(renderer->progress.pixels, &view, y0, y1);
+            else {
+                iterStateAdvanceRows(&renderer->state, view.maxIterations, y0, y1);
+                #ifndef TIME_MEASURE
+                drawIterations(renderer->progress.pixels, &renderer->state, view.maxIterations, y0, y1);
+                #endif
+            }
+
+            std::lock_guard<std::mutex> guard(renderer->lock);
+            for (int y = y0; y < y1; y++)
+                renderer->progress.rowDone[y] = true;
+            renderer->updated = true;
+            // после последней полосы кадр уже готов, и его не бросают
+            cancelled = b + 1 < bandCount && (renderer->stop || renderer->generation != generation);
+        }
+        if (cancelled)
+            continue;
+
+        if (!view.distMode && renderer->state.maxIterations > before) {
+            unsaved     = true;
+            unsavedView = view;
+        }
+
+        #ifdef TIME_MEASURE
+        unsigned long long end = __rdtsc();
+        unsigned long long elapsedTime = end - start;
+        cntForTick++;
+        all_time += elapsedTime;
+        if (cntForTick == LIMIT) {
+            printf("Elapsed time: %llu cycles\n", all_time / LIMIT);
+        }
+        #endif
+
+        std::lock_guard<std::mutex> guard(renderer->lock);
+        std::swap(renderer->progress, renderer->complete);
+        renderer->progress.valid = false;
+        renderer->updated = true;
+        done = generation;
+    }
+}
+
+inline void requestRender(Renderer* renderer, const View* view) {
+    std::lock_guard<std::mutex> guard(renderer->lock);
+    renderer->request = *view;
+    renderer->generation++;
+    renderer->wake.notify_one();
+}
+
+inline void createFrame(Frame* frame) {
+    frame->pixels  = new sf::Uint8[WIDTH * HEIGHT * 4]();
+    frame->rowDone = new bool[HEIGHT]();
+    frame->valid   = false;
+}
+
+inline void destroyFrame(Frame* frame) {
+    delete[] frame->pixels;
+    delete[] frame->rowDone;
+}
+
+inline void startRenderer(Renderer* renderer, const View* view) {
+    createFrame(&renderer->progress);
+    createFrame(&renderer->complete);
+    iterStateCreate(&renderer->state, WIDTH, HEIGHT, RADIUS);
+
+    renderer->request    = *view;
+    renderer->generation = 1;
+    renderer->stop       = false;
+    renderer->updated    = false;
+    renderer->worker     = std::thread(renderLoop, renderer);
+}
+
+inline void stopRenderer(Renderer* renderer) {
+    {
+        std::lock_guard<std::mutex> guard(renderer->lock);
+        renderer->stop = true;
+        renderer->wake.notify_one();
+    }
+    renderer->worker.join();
+
+    iterStateDestroy(&renderer->state);
+    destroyFrame(&renderer->progress);
+    destroyFrame(&renderer->complete);
+}
+
+// Основной поток только обрабатывает ввод и показывает кадр: при смене вида
+// прошлый кадр сразу переносится на новый вид, а фоновый поток досчитывает
+// открывшиеся области и затем весь кадр в полном качестве
+inline void processEvents(sf::RenderWindow* window, View* view, Renderer* renderer, sf::Uint8* screen, sf::Texture* texture, sf::Sprite* sprite, sf::Text* fpsText, sf::Clock* gameClock, int* frames) {
+    int cntForFps = 0;
+    unsigned long long all_fps = 0;
+
+    Drag drag = {};
+    sf::RectangleShape dragRect;
+    dragRect.setFillColor(sf::Color(255, 255, 255, 40));
+    dragRect.setOutlineColor(sf::Color(255, 255, 255, 160));
+    dragRect.setOutlineThickness(1);
+
+    View requested = *view;
+    bool dirty = true;
+
+    while (window->isOpen()) {
+        handleKeyPress(window, view, &drag);
+
+        if (!sameRequest(view, &requested)) {
+            requested = *view;
+            requestRender(renderer, view);
+            dirty = true;
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(renderer->lock);
+            if (dirty || renderer->updated) {
+                memset(screen, 0, WIDTH * HEIGHT * 4);
+                reproject(screen, view, &renderer->complete);
+                reproject(screen, view, &renderer->progress);
+                renderer->updated = false;
+                dirty = false;
+                texture->update(screen);
+            }
+        }
+
+        cntForFps++;
+
+        window->clear();
+        window->draw(*sprite);
+
+        if (drag.active) {
+            dragRect.setPosition(std::min(drag.x0, drag.x1), std::min(drag.y0, drag.y1));
+            dragRect.setSize(sf::Vector2f(abs(drag.x1 - drag.x0), abs(drag.y1 - drag.y0)));
+            window->draw(dragRect);
+        }
+
+        writeFPS(window, fpsText, gameClock, frames, &cntForFps, &all_fps);
+
+        window->display();
+    }
+}
+
+inline void initialize(sf::RenderWindow* window, sf::Texture* texture, sf::Sprite* sprite, sf::Text* fpsText, sf::Font* font) {
+    window->create(sf::VideoMode(WIDTH, HEIGHT), "Mandelbrot Set");
+    window->setFramerateLimit(FRAME_LIMIT);
+
+    texture->create(WIDTH, HEIGHT);
+    sprite->setTexture(*texture);
+
+    font->loadFromFile("arial.ttf");
+    fpsText->setFont(*font);
+    fpsText->setCharacterSize(20);
+    fpsText->setFillColor(sf::Color::Red);
+    fpsText->setPosition(10, 10);
+}
+
+int main() {
+    sf::RenderWindow window;
+    sf::Texture      texture;
+    sf::Sprite       sprite;
+    sf::Text         fpsText;
+    sf::Font         font;
+
+    initialize(&window, &texture, &sprite, &fpsText, &font);
+
+    sf::Clock gameClock;
+    int frames = 0;
+
+    View view = {0.f, 0.f, 1.0f, MAX_ITERATIONS, false};
+
+    Renderer renderer;
+    startRenderer(&renderer, &view);
+
+    sf::Uint8* screen = new sf::Uint8[WIDTH * HEIGHT * 4]();
+
+    processEvents(&window, &view, &renderer, screen, &texture, &sprite, &fpsText, &gameClock, &frames);
+
+    stopRenderer(&renderer);
+    delete[] screen;
+    return 0;
+}